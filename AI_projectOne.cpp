@@ -7,49 +7,50 @@
 //					-https://www.youtube.com/watch?v=iJ-NSxH3QNc which was a tutorial on implementing
 //					 custom comparators for priority queues
 //
-//				 One of the reasons why this program uses up so many lines of code is because I often
-//               hardcode the process of converting two-dimensional arrays to strings to pass between
-//               functions and vice-versa. I did this because I read that it is quite difficult in C++
-//               to pass two-dimensional arrays into and from functions. Since this is my first major
-//               project using C++, which I have been teaching myself, I did it this way to make it easier
-//               to code
+//				 States are passed between functions packed into a single 64-bit integer, with 4 bits per
+//               tile stored row by row, rather than as two-dimensional arrays or strings. This keeps each
+//               node of the search small and lets states be compared and hashed as plain integers
 //============================================================================
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <queue>
+#include <algorithm>
+#include <functional>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
 #include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 using namespace std;
 
-//Struct which stores the initial and goal states of the problem
-//Used in the inputProcessing method
-struct stringContainer {
-	string initial;
-	string goal;
-} initialAndGoal, problem;
-
-//Struct which stores whether a node can generate child nodes for the up, down, left and right directions
-//If a blank space is in a position where going up, down, left, or right are impossible, this data structure
-//will store that
-struct movesViabilityStore {
-	bool up;
-	bool down;
-	bool left;
-	bool right;
+//Struct which stores the initial and goal states of the problem packed into 64 bits each
+//(4 bits per tile, row by row). Produced by the parsePuzzleFile method and used by the search methods
+struct packedProblem{
+	unsigned long long initial;
+	unsigned long long goal;
 };
 
 //Struct which represents a node in the a* search algorithm
+//The state is packed into 64 bits the same way as in packedProblem
 struct node{
 	int originDirection;
-	int state[4][4];
+	unsigned long long state;
 	node* parent;
 	int gVal;
 	int hVal;
 	int fVal;
-	bool isRoot = false;
 };
 
+//Values stored in the depth of a solution when no solution was found
+//depthNotSolved: the search reached its memory cap before reaching the goal
+//depthUnsolvable: the goal state cannot be reached from the initial state at all
+const int depthNotSolved = -1;
+const int depthUnsolvable = -2;
+
 //Struct which stores the data from a* search which will be passed into the main method and
 //printed into a text file
 struct sol{
@@ -59,507 +60,645 @@ struct sol{
 	int nodeNum;
 };
 
+//Struct which stores the information kept for each state in the shared reverse search tree
+//The parent is the neighbouring state one move closer to the goal, and originDirection is the
+//direction the blank space moved to get from the parent to this state
+//Closed states have been expanded, and their g(n) value is the shortest distance to the goal
+struct reverseEntry{
+	unsigned long long parent;
+	int originDirection;
+	int gVal;
+	bool closed;
+};
+
+//Struct which represents a state waiting in the frontier of the reverse search tree
+struct reverseFrontierItem{
+	int fVal;
+	int gVal;
+	unsigned long long state;
+};
+
+//Struct which represents an a* search grown backward from a goal state, kept between all of the problems
+//which share that goal. The g(n) value of each state is measured from the goal, and h(n) is the Manhattan
+//distance to the initial state currently being searched for (the target). States are stored packed into
+//64 bits (4 bits per tile, row by row) so thousands of initial states can share one tree
+struct reverseSearchTree{
+	unsigned long long goal;
+	bool hasGoal = false;
+	unsigned long long target;
+	bool hasTarget = false;
+	int targetIndex[16];
+	size_t maxNodes = 4000000;
+	//The number of states added to the tree since it was created, and a running average of the number of
+	//states added by one search
+	size_t generated = 0;
+	size_t averageSearch = 0;
+	unordered_map<unsigned long long, reverseEntry> explored;
+	vector<reverseFrontierItem> frontier;
+};
+
 //Custom comparator for the frontier priority queue
 //Compares the f(n) values of two nodes and returns whether the first node
 //has a greater f(n) value
 class nodeCompare{
 public:
-	int operator()(node a, node b){
-		return a.fVal > b.fVal;
+	bool operator()(const node* a, const node* b){
+		return a->fVal > b->fVal;
 	}
 };
 
-//Function which calculates the sum of the Manhattan distances of a state
-//Takes a string which represents the state of the node, and a string which represents the goal state
-//Outputs a integer which represents the sum of Manhattan distances of the state
-int calcHeuristic(string inState, string inGoal){
-	int stateArr[4][4];
-	int goalArr[4][4];
-
-	//Parses the state string into a 2D array
-	int iRow = 0;
-	int iCol = 0;
-	stringstream stateStream(inState);
-	while(stateStream.good()){
-		string sub;
-		getline(stateStream, sub, ',');
-		stateArr[iRow][iCol] = stoi(sub);
-
-		iCol++;
-		if(iCol >= 4){
-			iCol = 0;
-			iRow++;
-		}
-	}
-
-	//Parses the goal string into a 2D array
-	iRow = 0;
-	iCol = 0;
-	stringstream goalHeurStream(inGoal);
-	while(goalHeurStream.good()){
-		string sub;
-		getline(goalHeurStream, sub, ',');
-		goalArr[iRow][iCol] = stoi(sub);
-
-		iCol++;
-		if(iCol >= 4){
-			iCol = 0;
-			iRow++;
-		}
-	}
-
-	//Finds the sum of the Manhattan distances of all elements of the array
-	//For each element of the current state, it adds the absolute value of the difference of rows
-	//to the absolute value of the difference of columns, and adds this to a running sum for all elements
-	//of the array
-	int cur = 0;
-	int sum = 0;
-	for(int i = 0; i < 4; i++){
-		for(int j = 0; j < 4; j++){
-			cur = stateArr[i][j];
-			for(int iRowGoal = 0; iRowGoal < 4; iRowGoal++){
-				for(int iColGoal = 0; iColGoal < 4; iColGoal++){
-					if(goalArr[iRowGoal][iColGoal] == cur){
-						sum += abs(iRowGoal - i) + abs(iColGoal - j);
-					}
-				}
-			}
+//Custom comparator for the frontier of the reverse search tree
+//Compares the f(n) values of two states, and prefers the deeper state when they are the same
+class reverseCompare{
+public:
+	bool operator()(const reverseFrontierItem& a, const reverseFrontierItem& b){
+		if(a.fVal != b.fVal){
+			return a.fVal > b.fVal;
 		}
+		return a.gVal < b.gVal;
 	}
+};
 
-	return sum;
+//Function which returns the tile stored at the given index (0 to 15, row by row) of a packed state
+int packedTile(unsigned long long inState, int index){
+	return static_cast<int>((inState >> (4 * index)) & 0xF);
 }
 
+//Function which returns the column of the tile at the given index (counting from 0) of a line of an input file
+//Only used to report errors, so it simply reads the line again
+size_t tileColumn(const char* lineBegin, const char* lineEnd, int index){
+	const char* p = lineBegin;
+	while(p < lineEnd){
+		if(static_cast<unsigned int>(static_cast<unsigned char>(*p) - '0') < 10){
+			if(index == 0){
+				break;
+			}
+			index--;
+			while(p < lineEnd && static_cast<unsigned int>(static_cast<unsigned char>(*p) - '0') < 10){
+				p++;
+			}
+		}
+		else{
+			p++;
+		}
+	}
+	return p - lineBegin + 1;
+}
 
-//Function to determine if a node contains a goal state
-bool goalCheck(node inNode, string inGoal){
-	int goalCheckArr[4][4];
-
-	//Parses the goal string into a 2D array
-	int iRow = 0;
-	int iCol = 0;
-	stringstream goalCheckStream(inGoal);
-	while(goalCheckStream.good()){
-		string sub;
-		getline(goalCheckStream, sub, ',');
-		goalCheckArr[iRow][iCol] = stoi(sub);
+//Function which reads puzzles from an input file and passes each one to onPuzzle as soon as it is read,
+//so even very large files never have to be held as a list of problems
+//The file is memory mapped and parsed in one pass, with the digits of each tile going straight into
+//the packed states. Two layouts are accepted, chosen by the number of tiles on the first non-empty line:
+//	-The original layout: four lines of four tiles for the initial state, a blank line, and four lines
+//	 of four tiles for the goal state. Several of these may follow each other in one file
+//	-The bulk layout: one puzzle per line, with the 16 tiles of the initial state followed by the
+//	 16 tiles of the goal state
+//Tiles may be separated by spaces, tabs or commas. Returns false and sets the error message, including
+//the line and column of the problem, if the file cannot be read or is not in one of these layouts
+//If onPuzzle returns false, parsing stops and false is returned, with the error message left to onPuzzle
+bool parsePuzzleFile(string textFile, const function<bool(packedProblem)>& onPuzzle, string& error){
+	int fd = open(textFile.c_str(), O_RDONLY);
+	if(fd < 0){
+		error = textFile + ": cannot open file";
+		return false;
+	}
+	struct stat fileInfo;
+	if(fstat(fd, &fileInfo) != 0 || fileInfo.st_size == 0){
+		close(fd);
+		error = textFile + ": file is empty or cannot be read";
+		return false;
+	}
+	size_t size = static_cast<size_t>(fileInfo.st_size);
+	void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(mapped == MAP_FAILED){
+		error = textFile + ": cannot map file";
+		return false;
+	}
+	madvise(mapped, size, MADV_SEQUENTIAL);
+	const char* data = static_cast<const char*>(mapped);
+	const char* dataEnd = data + size;
+
+	//Tiles of the current line are packed into lineState as they are read, and once the line is
+	//complete they are moved into the initial or goal state of the puzzle being built
+	int lineWidth = 0;
+	int linesInPuzzle = 0;
+	unsigned long long puzzle[2] = {0, 0};
+	int puzzleMask[2] = {0, 0};
+	size_t puzzleLine = 1;
+	size_t lineNum = 1;
+	size_t puzzleCount = 0;
+	bool ok = true;
+
+	//Builds the error message for the given line and column of the file
+	auto failAt = [&](size_t line, size_t column, string message){
+		error = textFile + ":" + to_string(line) + ":" + to_string(column) + ": " + message;
+		ok = false;
+	};
+
+	//Passes on a finished puzzle. Repeated tiles have already been caught as the tiles were read, so each
+	//state holds every tile from 0 to 15 exactly once
+	auto finishPuzzle = [&](){
+		packedProblem next;
+		next.initial = puzzle[0];
+		next.goal = puzzle[1];
+		puzzleCount++;
+		if(!onPuzzle(next)){
+			ok = false;
+		}
+		puzzle[0] = 0;
+		puzzle[1] = 0;
+		puzzleMask[0] = 0;
+		puzzleMask[1] = 0;
+		linesInPuzzle = 0;
+	};
+
+	const char* lineBegin = data;
+	while(ok && lineBegin < dataEnd){
+		//Finds the end of the line in one call rather than checking every character for a line break
+		const char* lineEnd = static_cast<const char*>(memchr(lineBegin, '\n', dataEnd - lineBegin));
+		if(lineEnd == NULL){
+			lineEnd = dataEnd;
+		}
 
-		iCol++;
-		if(iCol >= 4){
-			iCol = 0;
-			iRow++;
+		//Reads the tiles of the line. The tiles of the state being read are kept in curState and curMask until
+		//all sixteen have been read, with a bit of curMask set for every tile so a repeated tile is caught as
+		//soon as it is read. Tiles have at most two digits, so they are read directly rather than in a loop,
+		//and the single separator that usually follows a tile is skipped straight away
+		unsigned long long lineState[2] = {0, 0};
+		int lineMask[2] = {0, 0};
+		unsigned long long curState = 0;
+		int curMask = 0;
+		int lineTiles = 0;
+		const char* p = lineBegin;
+		while(p < lineEnd){
+			unsigned int digit = static_cast<unsigned char>(*p) - '0';
+			if(digit < 10){
+				size_t column = p - lineBegin + 1;
+				unsigned int value = digit;
+				p++;
+				if(p < lineEnd && (digit = static_cast<unsigned char>(*p) - '0') < 10){
+					value = value * 10 + digit;
+					p++;
+					if(value > 15 || (p < lineEnd && static_cast<unsigned int>(static_cast<unsigned char>(*p) - '0') < 10)){
+						failAt(lineNum, column, "tile value out of range (0 to 15)");
+						break;
+					}
+				}
+				if(lineTiles == 32){
+					failAt(lineNum, column, "too many tiles on this line");
+					break;
+				}
+				if(curMask & (1 << value)){
+					bool inGoal = lineTiles >= 16 || linesInPuzzle >= 4;
+					failAt(lineNum, column, string(inGoal ? "goal" : "initial") + " state repeats tile " + to_string(value));
+					break;
+				}
+				curState |= static_cast<unsigned long long>(value) << (4 * (lineTiles & 15));
+				curMask |= 1 << value;
+				lineTiles++;
+				if((lineTiles & 15) == 0){
+					lineState[(lineTiles >> 4) - 1] = curState;
+					lineMask[(lineTiles >> 4) - 1] = curMask;
+					curState = 0;
+					curMask = 0;
+				}
+				if(p < lineEnd && *p == ' '){
+					p++;
+				}
+			}
+			else if(*p == ' ' || *p == '\t' || *p == ',' || *p == '\r'){
+				p++;
+			}
+			else{
+				failAt(lineNum, p - lineBegin + 1, string("unexpected character '") + *p + "'");
+				break;
+			}
 		}
-	}
+		if((lineTiles & 15) != 0){
+			lineState[lineTiles >> 4] = curState;
+			lineMask[lineTiles >> 4] = curMask;
+		}
+		size_t lineLength = lineEnd - lineBegin;
 
-	//Is the goal state the same as the state the node contains
-	bool isSame = true;
-	for(int i = 0; i < 4; i++){
-		for(int j = 0; j < 4; j++){
-			if(inNode.state[i][j] != goalCheckArr[i][j]){
-				isSame = false;
+		//Empty lines only separate states and puzzles
+		if(ok && lineTiles != 0){
+			if(lineWidth == 0){
+				if(lineTiles != 4 && lineTiles != 32){
+					failAt(lineNum, lineLength + 1, "expected 4 or 32 tiles on a line, found " + to_string(lineTiles));
+				}
+				lineWidth = lineTiles;
+			}
+			if(ok && lineTiles != lineWidth){
+				failAt(lineNum, lineLength + 1, "expected " + to_string(lineWidth) + " tiles on this line, found " + to_string(lineTiles));
+			}
+			if(ok){
+				if(linesInPuzzle == 0){
+					puzzleLine = lineNum;
+				}
+				if(lineWidth == 32){
+					puzzle[0] = lineState[0];
+					puzzle[1] = lineState[1];
+					puzzleMask[0] = lineMask[0];
+					puzzleMask[1] = lineMask[1];
+					finishPuzzle();
+				}
+				else{
+					//Four lines make up the initial state and the next four make up the goal state
+					//A tile on this line which is already on an earlier line of the same state is a repeat
+					int k = linesInPuzzle / 4;
+					int repeated = lineMask[0] & puzzleMask[k];
+					if(repeated != 0){
+						int index = 0;
+						while(!(repeated & (1 << packedTile(lineState[0], index)))){
+							index++;
+						}
+						failAt(lineNum, tileColumn(lineBegin, lineEnd, index), string(k == 0 ? "initial" : "goal")
+								+ " state repeats tile " + to_string(packedTile(lineState[0], index)));
+					}
+					else{
+						puzzle[k] |= lineState[0] << (16 * (linesInPuzzle % 4));
+						puzzleMask[k] |= lineMask[0];
+						linesInPuzzle++;
+						if(linesInPuzzle == 8){
+							finishPuzzle();
+						}
+					}
+				}
 			}
 		}
+
+		lineNum++;
+		lineBegin = lineEnd + 1;
 	}
-	return isSame;
+
+	if(ok && linesInPuzzle != 0){
+		failAt(puzzleLine, 1, "incomplete puzzle, expected 8 lines of 4 tiles starting here");
+	}
+	if(ok && puzzleCount == 0){
+		failAt(1, 1, "no puzzles found");
+	}
+
+	munmap(mapped, size);
+	return ok;
 }
 
-//Function to determine which directions the blank space of a node can move in for the next move
-movesViabilityStore movesViable(node inNode){
-	movesViabilityStore viab;
-	int blankRow = 0;
-	int blankCol = 0;
-	for(blankRow; blankRow < 4; blankRow++){
-		for(blankCol; blankCol < 4; blankCol++){
-			if(inNode.state[blankRow][blankCol] == 0){
-				break;
-			}
-		}
+//Function which calculates the sum of the Manhattan distances of a packed state
+//Works the same way as calcHeuristic, but without parsing strings for every node
+int calcHeuristicPacked(unsigned long long inState, unsigned long long inGoal){
+	int goalIndex[16];
+	for(int i = 0; i < 16; i++){
+		goalIndex[packedTile(inGoal, i)] = i;
 	}
 
-	//Is moving the blank space up viable?
-	if(blankRow != 0){
-		viab.up = true;
+	int sum = 0;
+	for(int i = 0; i < 16; i++){
+		int target = goalIndex[packedTile(inState, i)];
+		sum += abs(target / 4 - i / 4) + abs(target % 4 - i % 4);
 	}
-	else{
-		viab.up = false;
+	return sum;
+}
+
+//Function which moves the blank space of a packed state in the given direction
+//(0 = up, 1 = down, 2 = left, 3 = right) and stores the result in outState
+//Returns false if the blank space cannot move in that direction
+bool movePacked(unsigned long long inState, int direction, unsigned long long& outState){
+	int blank = 0;
+	while(blank < 16 && packedTile(inState, blank) != 0){
+		blank++;
 	}
-	//Is moving the blank space down viable?
-	if(blankRow != 3){
-		viab.down = true;
+	if(blank >= 16){
+		return false;
 	}
-	else{
-		viab.down = false;
+
+	int blankRow = blank / 4;
+	int blankCol = blank % 4;
+	int target;
+	if(direction == 0 && blankRow != 0){
+		target = blank - 4;
 	}
-	//Is moving the blank space left viable?
-	if(blankCol != 0){
-		viab.left = true;
+	else if(direction == 1 && blankRow != 3){
+		target = blank + 4;
 	}
-	else{
-		viab.left = false;
+	else if(direction == 2 && blankCol != 0){
+		target = blank - 1;
 	}
-	//Is moving the blank space right viable?
-	if(blankCol != 3){
-		viab.right = true;
+	else if(direction == 3 && blankCol != 3){
+		target = blank + 1;
 	}
 	else{
-		viab.right = false;
+		return false;
 	}
 
-	return viab;
+	//Swaps the blank space with the tile it moves onto
+	unsigned long long tile = static_cast<unsigned long long>(packedTile(inState, target));
+	outState = inState & ~(0xFULL << (4 * target));
+	outState |= tile << (4 * blank);
+	return true;
 }
 
-stringContainer inputProcessing(string textFile){
-	//INPUT PROCESSING SECTION
-	//Reads from the input file, at the end produces two arrays: one represents the initial state,
-	//the other represents the goal state
-	fstream inputFile(textFile);
-
-	//Reads from the input file, separating it into two strings, one for the intial
-	//state and another for the goal state
-
-	int lineNum = 0;
-	string initialStr = "";
-	string goalStr = "";
-	string curLine;
-	if(inputFile.is_open()){
-		while(getline(inputFile, curLine)){
-			if(lineNum < 4){
-				initialStr += curLine;
-			}
-			else if(lineNum > 4){
-				goalStr += curLine;
+//Function which returns the index (0 to 15, row by row) of the blank space of a packed state
+int blankIndex(unsigned long long inState){
+	int blank = 0;
+	while(blank < 15 && packedTile(inState, blank) != 0){
+		blank++;
+	}
+	return blank;
+}
+
+//Function which returns the Manhattan distance between two indexes of the board
+int indexDistance(int a, int b){
+	return abs(a / 4 - b / 4) + abs(a % 4 - b % 4);
+}
+
+//Function which determines whether the goal state can be reached from the initial state
+//Every move swaps the blank space with a tile, so it flips the parity of the permutation between the
+//two states and also flips the parity of the distance of the blank space from its place in the goal.
+//The goal can only be reached if these two parities are the same
+bool isSolvable(unsigned long long inInitial, unsigned long long inGoal){
+	int goalIndex[16];
+	for(int i = 0; i < 16; i++){
+		goalIndex[packedTile(inGoal, i)] = i;
+	}
+
+	//Counts the swaps needed to sort the permutation, one less than the length of each cycle
+	bool visited[16] = {false};
+	int swaps = 0;
+	for(int i = 0; i < 16; i++){
+		int j = i;
+		while(!visited[j]){
+			visited[j] = true;
+			j = goalIndex[packedTile(inInitial, j)];
+			if(!visited[j]){
+				swaps++;
 			}
-			lineNum++;
 		}
-		inputFile.close();
 	}
 
-	//Formats the initial and goal strings to remove line breaks and spaces
-	for(int i = 0; i < initialStr.size(); i++){
-		if(!isdigit(initialStr[i])){
-			initialStr[i] = ',';
+	int blankDistance = indexDistance(blankIndex(inInitial), blankIndex(inGoal));
+	return swaps % 2 == blankDistance % 2;
+}
+
+//Function which calculates h(n) for the reverse search tree: the sum of the Manhattan distances of the tiles
+//of a state from their places in the target. The blank space is left out so h(n) never overestimates, which
+//means every state the tree closes has its shortest distance to the goal, whichever target it was closed for
+int reverseHeuristic(reverseSearchTree& tree, unsigned long long inState){
+	int sum = 0;
+	for(int i = 0; i < 16; i++){
+		int tile = packedTile(inState, i);
+		if(tile != 0){
+			sum += indexDistance(i, tree.targetIndex[tile]);
 		}
 	}
+	return sum;
+}
 
-	string initialFormat = "";
-	stringstream s_stream(initialStr);
-	while(s_stream.good()){
-		string sub;
-		getline(s_stream, sub, ',');
-		if(sub[0] != '\0'){
-			initialFormat += sub + ',';
-		}
+//Function which clears a reverse search tree and starts it again from a new goal state
+//The goal is the only state in the tree to begin with, with a g(n) value of 0
+void reverseTreeReset(reverseSearchTree& tree, unsigned long long inGoal){
+	tree.explored.clear();
+	tree.frontier.clear();
+	tree.goal = inGoal;
+	tree.hasGoal = true;
+	tree.hasTarget = false;
+
+	reverseEntry root;
+	root.parent = inGoal;
+	root.originDirection = -1;
+	root.gVal = 0;
+	root.closed = false;
+	tree.explored[inGoal] = root;
+	tree.generated++;
+
+	reverseFrontierItem rootItem;
+	rootItem.fVal = 0;
+	rootItem.gVal = 0;
+	rootItem.state = inGoal;
+	tree.frontier.push_back(rootItem);
+}
+
+//Function which points the frontier of a reverse search tree at a new initial state
+//Every entry in the frontier gets its f(n) value worked out again with the new h(n). Entries left behind by states
+//which have since been closed or reached by a shorter path are kept, since they are skipped when they are popped
+void reverseTreeRetarget(reverseSearchTree& tree, unsigned long long inTarget){
+	tree.target = inTarget;
+	tree.hasTarget = true;
+	for(int i = 0; i < 16; i++){
+		tree.targetIndex[packedTile(inTarget, i)] = i;
 	}
 
-	for(int i = 0; i < goalStr.size(); i++){
-		if(!isdigit(goalStr[i])){
-			goalStr[i] = ',';
-		}
+	for(size_t i = 0; i < tree.frontier.size(); i++){
+		tree.frontier[i].fVal = tree.frontier[i].gVal + reverseHeuristic(tree, tree.frontier[i].state);
+	}
+	make_heap(tree.frontier.begin(), tree.frontier.end(), reverseCompare());
+}
+
+//Function which solves a problem using a reverse search tree grown from its goal state
+//If the initial state has already been closed by the tree, the answer is read straight from it. Otherwise the
+//frontier is pointed at the initial state and the tree is expanded with a* search only until the initial state
+//is closed, so each new problem only adds the part of the tree that earlier problems did not already cover
+//If the tree fills up, it is started again from the goal once, so states kept for earlier problems do not
+//stop this one from being solved. Returns false, with the depth set to depthNotSolved, if even the new tree
+//reaches its memory cap first
+bool reverseTreeSolve(reverseSearchTree& tree, packedProblem problemPara, sol& mySol){
+	unsigned long long goal = problemPara.goal;
+	unsigned long long initial = problemPara.initial;
+
+	//If this problem has a different goal, the old tree cannot be reused
+	size_t generatedBefore = tree.generated;
+	bool freshTree = false;
+	if(!tree.hasGoal || tree.goal != goal){
+		reverseTreeReset(tree, goal);
+		freshTree = true;
 	}
 
-	string goalFormat = "";
-	stringstream s2_stream(goalStr);
-	while(s2_stream.good()){
-		string subTwo;
-		getline(s2_stream, subTwo, ',');
-		if(subTwo[0] != '\0'){
-			goalFormat += subTwo + ',';
+	//The initial state may already have been closed for an earlier problem. Otherwise the tree is searched until
+	//the initial state is popped from the frontier
+	unordered_map<unsigned long long, reverseEntry>::iterator found = tree.explored.find(initial);
+	bool reached = found != tree.explored.end() && found->second.closed;
+	//Pointing the frontier at the initial state costs one pass over the whole frontier. Once the frontier holds
+	//more states than an average search adds, that pass costs more than the states kept in the tree save, so the
+	//tree is started again instead
+	if(!reached){
+		if(!freshTree && tree.frontier.size() > max(tree.averageSearch, static_cast<size_t>(1000))){
+			reverseTreeReset(tree, goal);
+			freshTree = true;
 		}
+		reverseTreeRetarget(tree, initial);
 	}
 
-	//Cuts off the last comma from the initial and goal strings
-	//not doing so would cause problems when parsing this into an array
-	initialAndGoal.initial = initialFormat.substr(0, (initialFormat.size() - 1));
-	initialAndGoal.goal = goalFormat.substr(0, (goalFormat.size() - 1));
+	const int offsets[4] = {-4, 4, -1, 1};
+	while(!reached){
+		if(!freshTree && tree.explored.size() >= tree.maxNodes){
+			reverseTreeReset(tree, goal);
+			reverseTreeRetarget(tree, initial);
+			freshTree = true;
+		}
+		if(tree.frontier.empty() || tree.explored.size() >= tree.maxNodes){
+			mySol.depth = depthNotSolved;
+			mySol.nodeNum = static_cast<int>(tree.generated - generatedBefore);
+			return false;
+		}
 
-	return initialAndGoal;
-	//END OF INPUT PROCESSING SECTION
-}
+		//Pops the state with the lowest f(n) value, skipping entries which are out of date
+		pop_heap(tree.frontier.begin(), tree.frontier.end(), reverseCompare());
+		reverseFrontierItem item = tree.frontier.back();
+		tree.frontier.pop_back();
+		reverseEntry& curEntry = tree.explored.find(item.state)->second;
+		if(curEntry.closed || curEntry.gVal != item.gVal){
+			continue;
+		}
+		curEntry.closed = true;
+
+		//Generates the neighbouring states. Only one tile moves, so h(n) of each one is worked out
+		//from h(n) of the current state
+		unsigned long long cur = item.state;
+		int curH = item.fVal - item.gVal;
+		int blank = blankIndex(cur);
+		for(int direction = 0; direction < 4; direction++){
+			unsigned long long child;
+			if(!movePacked(cur, direction, child)){
+				continue;
+			}
+			int from = blank + offsets[direction];
+			int targetPos = tree.targetIndex[packedTile(cur, from)];
+			int childG = item.gVal + 1;
+			int childH = curH - indexDistance(from, targetPos) + indexDistance(blank, targetPos);
+
+			//Looks the child up and adds it in one step
+			reverseEntry entry;
+			entry.parent = cur;
+			entry.originDirection = direction;
+			entry.gVal = childG;
+			entry.closed = false;
+			pair<unordered_map<unsigned long long, reverseEntry>::iterator, bool> inserted = tree.explored.insert(make_pair(child, entry));
+			if(inserted.second){
+				tree.generated++;
+			}
+			else if(!inserted.first->second.closed && childG < inserted.first->second.gVal){
+				inserted.first->second = entry;
+			}
+			else{
+				continue;
+			}
 
-//Function which implements the actual a* search
-sol aStar(stringContainer problemPara){
-	sol mySol;
+			reverseFrontierItem childItem;
+			childItem.fVal = childG + childH;
+			childItem.gVal = childG;
+			childItem.state = child;
+			tree.frontier.push_back(childItem);
+			push_heap(tree.frontier.begin(), tree.frontier.end(), reverseCompare());
+		}
 
-	//Two-dimensional 4x4 arrays which will be used to store the initial and goal states
-	int goalState[4][4];
+		//The search stops once the initial state has been popped. Its neighbours are still generated first, so
+		//every closed state has been expanded and later problems can carry on the search from the frontier
+		reached = item.state == initial;
+	}
 
-	//Parses the goal string into a 2D array
-	int iRow = 0;
-	int iCol = 0;
-	stringstream goalStream(problemPara.goal);
-	while(goalStream.good()){
-		string sub;
-		getline(goalStream, sub, ',');
-		goalState[iRow][iCol] = stoi(sub);
+	//Keeps a running average of the states a search generates, used to decide when the tree is started again
+	size_t searchNodes = tree.generated - generatedBefore;
+	if(searchNodes != 0){
+		tree.averageSearch = (3 * tree.averageSearch + searchNodes) / 4;
+	}
 
-		iCol++;
-		if(iCol >= 4){
-			iCol = 0;
-			iRow++;
+	//Follow the parents from the initial state back to the goal. Each step undoes the move that
+	//generated the state in the tree, so the blank space moves in the opposite direction
+	int depth = tree.explored[initial].gVal;
+	string moves = "";
+	string funcStr = "";
+	unsigned long long cur = initial;
+	for(int g = 0; g <= depth; g++){
+		//f(n) is reported the same way as aStar does, with g(n) counted from the initial state
+		funcStr += to_string(g + calcHeuristicPacked(cur, goal)) + ' ';
+		if(g == depth){
+			break;
 		}
-	}
 
-	//Parses the initial string into a node
-	node root;
-	iRow = 0;
-	iCol = 0;
-	stringstream initialStream(problemPara.initial);
-	while(initialStream.good()){
-		string sub;
-		getline(initialStream, sub, ',');
-		root.state[iRow][iCol] = stoi(sub);
-		iCol++;
-		if(iCol >= 4){
-			iCol = 0;
-			iRow++;
+		reverseEntry entry = tree.explored[cur];
+		if(entry.originDirection == 0){
+			moves += "D ";
+		}
+		else if(entry.originDirection == 1){
+			moves += "U ";
+		}
+		else if(entry.originDirection == 2){
+			moves += "R ";
+		}
+		else if(entry.originDirection == 3){
+			moves += "L ";
 		}
+		cur = entry.parent;
 	}
 
+	//The number of nodes generated only counts the states added to the tree for this problem, which is 0 if
+	//the answer was already in the tree
+	mySol.depth = depth;
+	mySol.moveSet = moves;
+	mySol.funcSet = funcStr;
+	mySol.nodeNum = static_cast<int>(searchNodes);
+	return true;
+}
+
+//Function which implements the actual a* search
+sol aStar(packedProblem problemPara){
+	sol mySol;
+
+	//All of the nodes generated by the search. A deque is used so the address of a node does not change
+	//as more nodes are added, which lets nodes point to their parents, and all of them are freed together
+	//when the search returns
+	deque<node> nodes;
+
 	//Sets the parameters of the root node
-	root.parent = NULL;
-	root.gVal = 0;
-	root.hVal = calcHeuristic(problemPara.initial, problemPara.goal);
-	root.fVal = root.gVal + root.hVal;
-	root.isRoot = true;
+	nodes.push_back(node());
+	node* root = &nodes.back();
+	root->state = problemPara.initial;
+	root->originDirection = -1;
+	root->parent = NULL;
+	root->gVal = 0;
+	root->hVal = calcHeuristicPacked(problemPara.initial, problemPara.goal);
+	root->fVal = root->gVal + root->hVal;
 
 	//The frontier of A* search, represented by a priority queue
 	//Priority is represented by the f(n) values of the nodes
-	std::priority_queue<node, vector<node>, nodeCompare> frontier;
+	std::priority_queue<node*, vector<node*>, nodeCompare> frontier;
 
-	//The list of explored states, represented by a vector of nodes
-	vector<string> explored;
+	//The set of states which have already been generated
+	unordered_set<unsigned long long> explored;
 
-	//List of all addresses which store nodes
-	//This is so it will be deleted later to avoid a stack overflow
-	vector<node*> addresses;
-
-	//Push the root node into the frontier and its state into the explored list
+	//Push the root node into the frontier and its state into the explored set
 	frontier.push(root);
-	explored.push_back(problemPara.initial);
+	explored.insert(problemPara.initial);
 
-	//Keeps the total number of lists, starting with one (the root node)
+	//Keeps the total number of nodes, starting with one (the root node)
 	int totalNodes = 1;
 
-	node myTop;
 	while(!frontier.empty()){
-		//Pops the top node from the frontier and stores it
-		node* myTop = new node();
-		for(int i = 0; i < 4; i++){
-			for(int j = 0; j < 4; j++){
-				myTop->state[i][j] = (frontier.top().state[i][j]);
-			}
-		}
-		myTop->gVal = (frontier.top().gVal);
-		myTop->hVal = (frontier.top().hVal);
-		myTop->fVal = (frontier.top().fVal);
-		myTop->parent = (frontier.top().parent);
-		myTop->originDirection = (frontier.top().originDirection);
+		//Pops the top node from the frontier
+		node* myTop = frontier.top();
 		frontier.pop();
 
 		//If the top node of the frontier is not a goal node
-		//See if the blank space (as represented in the node) can move up, down, left and right, and if so
+		//See if the blank space can move up, down, left and right (0 to 3), and if so
 		//generate child nodes to represent these moves
-		if(!goalCheck(*myTop, problemPara.goal)){
-			//Determine where the blank space is
-			int blankRow;
-			int blankCol;
-			for(int iterate = 0; iterate < 4; iterate++){
-				for(int jIterate = 0; jIterate < 4; jIterate++){
-					if(myTop->state[iterate][jIterate] == 0){
-						blankRow = iterate;
-						blankCol = jIterate;
-					}
-				}
-			}
-
-			//Stores what moves are viable
-			movesViabilityStore myVia = movesViable(*myTop);
-			//If "up" is a viable move
-			int temp;
-			if(myVia.up){
-				//Create new node
-				node* up = new node();
-				//Sets up the state of the node
-				for(int i = 0; i < 4; i++){
-					for(int j = 0; j < 4; j++){
-						up->state[i][j] = myTop->state[i][j];
-					}
-				}
-				temp = up->state[blankRow - 1][blankCol];
-				up->state[blankRow - 1][blankCol] = 0;
-				up->state[blankRow][blankCol] = temp;
-
-				//Converts state of the new node into a string
-				string myStateStringUp = "";
-				for(int i = 0; i < 4; i++){
-					for(int j = 0; j < 4; j++){
-						myStateStringUp += to_string(up->state[i][j]) + ',';
-					}
-				}
-				string myStateStringUpFormat = myStateStringUp.substr(0, (myStateStringUp.size() - 1));
-
-				//Sets up the paremeter of the new node
-				up->originDirection = 0;
-				up->parent = myTop;
-				up->gVal = myTop->gVal + 1;
-				up->hVal = calcHeuristic(myStateStringUpFormat, problemPara.goal);
-				up->fVal = up->gVal + up->hVal;
-
-				//Is the state in the explored list?
-				//Has this state already been generated by a* search?
-				bool isInExplored = false;
-				for(int i = 0; i < explored.size(); i++){
-					if((explored.at(i)).compare(myStateStringUpFormat) == 0){
-						isInExplored = true;
-					}
-				}
-				//If the state has not been previously explored, add it to the frontier, add its state to the explored list,
-				//add the memory address to the list of addresses, and increment the total number of nodes
-				if(!isInExplored){
-					addresses.push_back(up);
-					frontier.push(*up);
-					explored.push_back(myStateStringUpFormat);
-					totalNodes++;
-				}
-
-			}
-//			//Adding a node to represent moving the blank space down
-			if(myVia.down){
-				//Create new node
-				node* down = new node();
-				//Sets up the state of the node
-				for(int i = 0; i < 4; i++){
-					for(int j = 0; j < 4; j++){
-						down->state[i][j] = myTop->state[i][j];
-					}
-				}
-				temp = down->state[blankRow + 1][blankCol];
-				down->state[blankRow + 1][blankCol] = 0;
-				down->state[blankRow][blankCol] = temp;
-
-				//Converts state of the new node into a string
-				string myStateStringDown = "";
-				for(int i = 0; i < 4; i++){
-					for(int j = 0; j < 4; j++){
-						myStateStringDown += to_string(down->state[i][j]) + ',';
-					}
-				}
-				string myStateStringDownFormat = myStateStringDown.substr(0, (myStateStringDown.size() - 1));
-
-				//Sets up the parameter of the node
-				down->originDirection = 1;
-				down->parent = myTop;
-				down->gVal = myTop->gVal + 1;
-				down->hVal = calcHeuristic(myStateStringDownFormat, problemPara.goal);
-				down->fVal = down->gVal + down->hVal;
-
-				//Has the state already been explored?
-				bool isInExplored = false;
-				for(int i = 0; i < explored.size(); i++){
-					if((explored.at(i)).compare(myStateStringDownFormat) == 0){
-						isInExplored = true;
-					}
-				}
-				//If the node has not already been explored, add it to the frontier, add its state to the explored list,
-				//add the memory address to the list of addresses, and increment the total number of nodes
-				if(!isInExplored){
-					addresses.push_back(down);
-					frontier.push(*down);
-					explored.push_back(myStateStringDownFormat);
-					totalNodes++;
+		if(myTop->state != problemPara.goal){
+			for(int direction = 0; direction < 4; direction++){
+				unsigned long long childState;
+				if(!movePacked(myTop->state, direction, childState)){
+					continue;
 				}
 
-			}
-     		//Adding a node to represent moving the blank space left
-			if(myVia.left){
-				//Generate a new node
-				node* left = new node();
-				//Sets up the state of the node
-				for(int i = 0; i < 4; i++){
-					for(int j = 0; j < 4; j++){
-						left->state[i][j] = myTop->state[i][j];
-					}
-				}
-				temp = left->state[blankRow][blankCol - 1];
-				left->state[blankRow][blankCol - 1] = 0;
-				left->state[blankRow][blankCol] = temp;
-
-				//Converts state of the new node into a string
-				string myStateStringLeft = "";
-				for(int i = 0; i < 4; i++){
-					for(int j = 0; j < 4; j++){
-						myStateStringLeft += to_string(left->state[i][j]) + ',';
-					}
-				}
-				string myStateStringLeftFormat = myStateStringLeft.substr(0, (myStateStringLeft.size() - 1));
-
-				//Sets up the parameters of the node
-				left->originDirection = 2;
-				left->parent = myTop;
-				left->gVal = myTop->gVal + 1;
-				left->hVal = calcHeuristic(myStateStringLeftFormat, problemPara.goal);
-				left->fVal = left->gVal + left->hVal;
-
-				//Is the state in the explored list?
-				bool isInExplored = false;
-				for(int i = 0; i < explored.size(); i++){
-					if((explored.at(i)).compare(myStateStringLeftFormat) == 0){
-						isInExplored = true;
-					}
-				}
-				//If the state has not been previously explored, add it to the explored list, add the node to the frontier,
-				//add the memory address to the list of addresses, and increment the total number of nodes
-				if(!isInExplored){
-					addresses.push_back(left);
-					frontier.push(*left);
-					explored.push_back(myStateStringLeftFormat);
-					totalNodes++;
-				}
-
-			}
-			//Adding a node to represent moving the blank space right
-			if(myVia.right){
-				//Generate a new node
-				node* right = new node();
-				//Sets up the state
-				for(int i = 0; i < 4; i++){
-					for(int j = 0; j < 4; j++){
-						right->state[i][j] = myTop->state[i][j];
-					}
-				}
-				temp = right->state[blankRow][blankCol + 1];
-				right->state[blankRow][blankCol + 1] = 0;
-				right->state[blankRow][blankCol] = temp;
-
-				//Converts state of the new node into a string
-				string myStateStringRight = "";
-				for(int i = 0; i < 4; i++){
-					for(int j = 0; j < 4; j++){
-						myStateStringRight += to_string(right->state[i][j]) + ',';
-					}
-				}
-				string myStateStringRightFormat = myStateStringRight.substr(0, (myStateStringRight.size() - 1));
-
-				//Sets up the parameters of the node
-				right->originDirection = 3;
-				right->parent = myTop;
-				right->gVal = myTop->gVal + 1;
-				right->hVal = calcHeuristic(myStateStringRightFormat, problemPara.goal);
-				right->fVal = right->gVal + right->hVal;
-
-				//Has the state been explored?
-				bool isInExplored = false;
-				for(int i = 0; i < explored.size(); i++){
-					if((explored.at(i)).compare(myStateStringRightFormat) == 0){
-						isInExplored = true;
-					}
-				}
-				//If the state has not been explored, add it to the explored list, add the node to the frontier, add the memory
-				//address to the list of addresses, and increment the total number of nodes
-				if(!isInExplored){
-					addresses.push_back(right);
-					frontier.push(*right);
-					explored.push_back(myStateStringRightFormat);
+				//If the state has not been previously generated, add it to the frontier and the explored set,
+				//and increment the total number of nodes
+				if(explored.insert(childState).second){
+					nodes.push_back(node());
+					node* child = &nodes.back();
+					child->state = childState;
+					child->originDirection = direction;
+					child->parent = myTop;
+					child->gVal = myTop->gVal + 1;
+					child->hVal = calcHeuristicPacked(childState, problemPara.goal);
+					child->fVal = child->gVal + child->hVal;
+					frontier.push(child);
 					totalNodes++;
 				}
 			}
@@ -571,48 +710,24 @@ sol aStar(stringContainer problemPara){
 			//asked for in the specifications of the assignment
 			mySol.depth = myTop->gVal;
 
-			//Create a node to store the information of the top node in the frontier
-			node* end = new node();
-			end->parent = myTop->parent;
-			end->gVal = myTop->gVal;
-			end->hVal = myTop->hVal;
-			end->fVal = myTop->fVal;
-			end->originDirection = myTop->originDirection;
-
 			//Create lists which will store the moves made to reach the goal node
 			//and the f(n) values of the nodes
 			vector<char> moveReversed;
 			vector<int> funcStore;
 
-			//Starting from the current node, keep a list of the moves taken to get from the initial state to
+			//Starting from the goal node, keep a list of the moves taken to get from the initial state to
 			//the goal state, as well as the f(n) value of each node. This will be backwards (we start from the goal node and go back to the root) but will
 			//be reversed to the proper order later
-			while(end->parent != nullptr){
-				if(end->originDirection == 0){
-					moveReversed.push_back('U');
-				}
-				else if(end->originDirection == 1){
-					moveReversed.push_back('D');
-				}
-				else if(end->originDirection == 2){
-					moveReversed.push_back('L');
-				}
-				else if(end->originDirection == 3){
-					moveReversed.push_back('R');
-				}
+			const char moveLetters[4] = {'U', 'D', 'L', 'R'};
+			node* end = myTop;
+			while(end->parent != NULL){
+				moveReversed.push_back(moveLetters[end->originDirection]);
 				funcStore.push_back(end->fVal);
 				end = end->parent;
 			}
 
-			//Clear up all of the memory that was used to store the nodes
-			//Not doing this will lead to a stack overflow
-			int size = addresses.size();
-			for(int i = 0; i < size; i++){
-				delete (node*) addresses.at(i);
-			}
-
 			//Push the f(n) value of the root onto the list
-			funcStore.push_back(root.fVal);
+			funcStore.push_back(root->fVal);
 
 			//Reverse the order of the lists of the f(n) values of the nodes and the
 			// moves taken to get from the initial state to the goal state so they read in the correct order
@@ -638,76 +753,620 @@ sol aStar(stringContainer problemPara){
 	return mySol;
 }
 
+//Function which derives the name of the output file from the name of the input file
+//The whole name of the input file, without its directory and extension, is kept so different inputs get
+//different outputs. If it contains "Input", that is replaced with "Output" ("Input12.txt" gives "Output12.txt"
+//and "Input1x.txt" gives "Output1x.txt"). Otherwise "aStarResults_" is put in front ("a.txt" gives "aStarResults_a.txt")
+string outputFileName(string inputName){
+	size_t slash = inputName.find_last_of('/');
+	string stem = slash == string::npos ? inputName : inputName.substr(slash + 1);
+	size_t dot = stem.find_last_of('.');
+	if(dot != string::npos && dot > 0){
+		stem = stem.substr(0, dot);
+	}
+
+	size_t fIndex = stem.find("Input");
+	if(fIndex != string::npos){
+		return stem.substr(0, fIndex) + "Output" + stem.substr(fIndex + 5) + ".txt";
+	}
+	if(stem == "" || stem == "." || stem == ".."){
+		return "aStarResults.txt";
+	}
+	return "aStarResults_" + stem + ".txt";
+}
+
+//Magic number and version at the start of every binary result file
+const char resultMagic[4] = {'A', 'P', 'O', 'R'};
+const unsigned int resultVersion = 1;
+
+//Size of the buffers held by a result writer before they are written out
+const size_t resultBufferSize = 1 << 20;
+
+//Struct which represents an append-only sink for results
+//Results are collected in a buffer and only written to the file when the buffer is full or the writer is
+//closed, so millions of results can be written without a system call for each one
+//In the text encoding each result uses the original output layout. In the binary encoding each record holds:
+//	-The initial and goal states, packed into 64 bits each
+//	-The depth and the total number of nodes generated, as 32 bit integers
+//	-The moves, 2 bits each (0 = up, 1 = down, 2 = left, 3 = right), four to a byte
+//The binary file starts with the magic number and version, and the byte offset of every record is
+//appended to an index file with the same name followed by ".idx", as a 64 bit integer
+//Every number in both files is written little-endian, whatever the byte order of the machine
+struct resultWriter{
+	int fd = -1;
+	int indexFd = -1;
+	bool binary = false;
+	unsigned long long offset = 0;
+	string buffer;
+	string indexBuffer;
+};
+
+//Function which adds the lowest bytes of a number to a buffer, least significant byte first
+void appendLittleEndian(string& buffer, unsigned long long value, int bytes){
+	for(int i = 0; i < bytes; i++){
+		buffer += static_cast<char>((value >> (8 * i)) & 0xFF);
+	}
+}
+
+//Function which reads a number stored least significant byte first
+unsigned long long readLittleEndian(const char* data, int bytes){
+	unsigned long long value = 0;
+	for(int i = 0; i < bytes; i++){
+		value |= static_cast<unsigned long long>(static_cast<unsigned char>(data[i])) << (8 * i);
+	}
+	return value;
+}
+
+//Function which returns the length in bytes of the binary record starting at data, from the depth stored in it
+//Records with no solution store depthNotSolved or depthUnsolvable as the depth and have no moves
+size_t recordLength(const char* data){
+	int depth = static_cast<int>(readLittleEndian(data + 16, 4));
+	return 24 + (depth > 0 ? (static_cast<size_t>(depth) + 3) / 4 : 0);
+}
+
+//Function which writes out everything held in a buffer and empties it
+bool flushBuffer(int fd, string& buffer){
+	size_t written = 0;
+	while(written < buffer.size()){
+		ssize_t count = write(fd, buffer.data() + written, buffer.size() - written);
+		if(count < 0){
+			return false;
+		}
+		written += static_cast<size_t>(count);
+	}
+	buffer.clear();
+	return true;
+}
+
+//Function which writes out what is held in the buffers of a result writer
+//The records are always written before the index entries which point at them, so if the program stops
+//part way through, the index never points past the end of the result file
+bool resultWriterFlush(resultWriter& writer){
+	if(writer.fd >= 0 && !flushBuffer(writer.fd, writer.buffer)){
+		return false;
+	}
+	if(writer.indexFd >= 0 && !flushBuffer(writer.indexFd, writer.indexBuffer)){
+		return false;
+	}
+	return true;
+}
+
+//Function which writes out what is left in the buffers of a result writer and closes its files
+bool resultWriterClose(resultWriter& writer){
+	bool ok = resultWriterFlush(writer);
+	if(writer.fd > 1){
+		ok = (close(writer.fd) == 0) && ok;
+	}
+	if(writer.indexFd >= 0){
+		ok = (close(writer.indexFd) == 0) && ok;
+	}
+	writer.fd = -1;
+	writer.indexFd = -1;
+	writer.buffer.clear();
+	writer.indexBuffer.clear();
+	return ok;
+}
+
+//Function which opens a result writer
+//"-" writes text results to the standard output. Otherwise results are appended to the end of the file, or the
+//file is emptied first if truncate is set. Returns false and sets the error message if a file cannot be opened
+bool resultWriterOpen(resultWriter& writer, string outputName, bool binary, bool truncate, string& error){
+	writer.binary = binary;
+	writer.buffer.reserve(resultBufferSize);
+	if(outputName == "-" && !binary){
+		writer.fd = 1;
+		return true;
+	}
+
+	//Binary files are opened for reading as well, so an existing file can be checked before adding to it
+	int flags = (binary ? O_RDWR : O_WRONLY) | O_CREAT | (truncate ? O_TRUNC : O_APPEND);
+	writer.fd = open(outputName.c_str(), flags, 0644);
+	if(writer.fd < 0){
+		error = outputName + ": cannot open file for writing";
+		return false;
+	}
+	if(!binary){
+		return true;
+	}
+
+	//An existing binary file is only added to if it has the header of this format and version. This is checked
+	//before the index file is opened, so no index is created next to a file which is not a result file
+	struct stat fileInfo;
+	fstat(writer.fd, &fileInfo);
+	writer.offset = static_cast<unsigned long long>(fileInfo.st_size);
+	char header[24];
+	if(writer.offset != 0 && !(writer.offset >= 8 && pread(writer.fd, header, 8, 0) == 8
+			&& memcmp(header, resultMagic, 4) == 0 && readLittleEndian(header + 4, 4) == resultVersion)){
+		error = outputName + ": not a result file of this format, cannot add to it";
+		resultWriterClose(writer);
+		return false;
+	}
+
+	writer.indexFd = open((outputName + ".idx").c_str(), flags, 0644);
+	if(writer.indexFd < 0){
+		error = outputName + ".idx: cannot open file for writing";
+		resultWriterClose(writer);
+		return false;
+	}
+	writer.indexBuffer.reserve(resultBufferSize);
+	struct stat indexInfo;
+	fstat(writer.indexFd, &indexInfo);
+	unsigned long long indexSize = static_cast<unsigned long long>(indexInfo.st_size);
+
+	//A new binary file starts with the header
+	if(writer.offset == 0 && indexSize == 0){
+		writer.buffer.append(resultMagic, 4);
+		appendLittleEndian(writer.buffer, resultVersion, 4);
+		writer.offset = 8;
+		return true;
+	}
+
+	//An existing one is only added to if the last entry of its index points at a record which ends exactly at
+	//the end of the file
+	bool valid;
+	if(indexSize % 8 != 0){
+		valid = false;
+	}
+	else if(indexSize == 0){
+		valid = writer.offset == 8;
+	}
+	else{
+		char lastEntry[8];
+		unsigned long long lastOffset = 0;
+		if(pread(writer.indexFd, lastEntry, 8, static_cast<off_t>(indexSize - 8)) == 8){
+			lastOffset = readLittleEndian(lastEntry, 8);
+		}
+		valid = lastOffset >= 8 && lastOffset + 24 <= writer.offset
+				&& pread(writer.fd, header, 24, static_cast<off_t>(lastOffset)) == 24
+				&& lastOffset + recordLength(header) == writer.offset;
+	}
+	if(!valid){
+		error = outputName + ".idx: index does not match " + outputName + ", cannot add to it";
+		resultWriterClose(writer);
+		return false;
+	}
+	return true;
+}
+
+//Function which adds a state to the buffer in the text layout: four lines of four tiles and a blank line
+void appendStateText(string& buffer, unsigned long long inState){
+	for(int i = 0; i < 16; i++){
+		buffer += to_string((inState >> (4 * i)) & 0xF);
+		buffer += ' ';
+		if(i % 4 == 3){
+			buffer += '\n';
+		}
+	}
+	buffer += '\n';
+}
+
+//Function which adds one result to a result writer
+//Returns false if the buffer had to be written out and the write failed
+bool resultWriterAppend(resultWriter& writer, packedProblem problemPara, sol solution){
+	if(!writer.binary){
+		//Outputs the initial and goal states, followed by:
+		//Depth of the shallowest goal node
+		//The total number of nodes generated
+		//The set of moves taken to get from the initial state to the goal state
+		//The f(n) value of each node from the root node to the goal node
+		//If no solution was found, the depth is replaced by the reason and the last two lines are empty
+		appendStateText(writer.buffer, problemPara.initial);
+		appendStateText(writer.buffer, problemPara.goal);
+		if(solution.depth == depthNotSolved){
+			writer.buffer += "not solved within cap\n";
+		}
+		else if(solution.depth == depthUnsolvable){
+			writer.buffer += "no solution\n";
+		}
+		else{
+			writer.buffer += to_string(solution.depth) + '\n';
+		}
+		writer.buffer += to_string(solution.nodeNum) + '\n';
+		writer.buffer += solution.moveSet + '\n';
+		writer.buffer += solution.funcSet + '\n';
+	}
+	else{
+		appendLittleEndian(writer.indexBuffer, writer.offset, 8);
+
+		size_t start = writer.buffer.size();
+		appendLittleEndian(writer.buffer, problemPara.initial, 8);
+		appendLittleEndian(writer.buffer, problemPara.goal, 8);
+		appendLittleEndian(writer.buffer, static_cast<unsigned int>(solution.depth), 4);
+		appendLittleEndian(writer.buffer, static_cast<unsigned int>(solution.nodeNum), 4);
+
+		//Packs the moves four to a byte, reading the letters of the move set and skipping the spaces
+		unsigned char packedMoves = 0;
+		int moveCount = 0;
+		for(size_t i = 0; i < solution.moveSet.size(); i++){
+			char move = solution.moveSet[i];
+			int code;
+			if(move == 'U'){
+				code = 0;
+			}
+			else if(move == 'D'){
+				code = 1;
+			}
+			else if(move == 'L'){
+				code = 2;
+			}
+			else if(move == 'R'){
+				code = 3;
+			}
+			else{
+				continue;
+			}
+			packedMoves |= code << (2 * (moveCount % 4));
+			moveCount++;
+			if(moveCount % 4 == 0){
+				writer.buffer += static_cast<char>(packedMoves);
+				packedMoves = 0;
+			}
+		}
+		if(moveCount % 4 != 0){
+			writer.buffer += static_cast<char>(packedMoves);
+		}
+		writer.offset += writer.buffer.size() - start;
+	}
+
+	if(writer.buffer.size() >= resultBufferSize || writer.indexBuffer.size() >= resultBufferSize){
+		return resultWriterFlush(writer);
+	}
+	return true;
+}
+
+//Function which reads a binary result file and writes its records to the standard output in the text layout
+//Starts at the given record, using the index file to find it, and prints up to count records (all of them if
+//count is 0). The f(n) values are not stored in the binary file, so they are worked out again by replaying the moves
+bool readResults(string inputName, unsigned long long first, unsigned long long count, string& error){
+	int fd = open(inputName.c_str(), O_RDONLY);
+	if(fd < 0){
+		error = inputName + ": cannot open file";
+		return false;
+	}
+	struct stat fileInfo;
+	fstat(fd, &fileInfo);
+	size_t size = static_cast<size_t>(fileInfo.st_size);
+	if(size < 8){
+		close(fd);
+		error = inputName + ": not a result file";
+		return false;
+	}
+	void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(mapped == MAP_FAILED){
+		error = inputName + ": cannot map file";
+		return false;
+	}
+	madvise(mapped, size, MADV_SEQUENTIAL);
+	const char* data = static_cast<const char*>(mapped);
+
+	if(memcmp(data, resultMagic, 4) != 0 || readLittleEndian(data + 4, 4) != resultVersion){
+		munmap(mapped, size);
+		error = inputName + ": not a result file";
+		return false;
+	}
+
+	//Finds the first record to print in the index
+	size_t pos = 8;
+	if(first > 0){
+		int indexFd = open((inputName + ".idx").c_str(), O_RDONLY);
+		char entry[8];
+		if(indexFd < 0 || pread(indexFd, entry, 8, static_cast<off_t>(first * 8)) != 8){
+			if(indexFd >= 0){
+				close(indexFd);
+			}
+			munmap(mapped, size);
+			error = inputName + ".idx: no record " + to_string(first);
+			return false;
+		}
+		close(indexFd);
+		pos = static_cast<size_t>(readLittleEndian(entry, 8));
+		if(pos < 8 || pos > size){
+			munmap(mapped, size);
+			error = inputName + ".idx: record " + to_string(first) + " points outside " + inputName;
+			return false;
+		}
+	}
+
+	resultWriter output;
+	resultWriterOpen(output, "-", false, false, error);
+	bool ok = true;
+	for(unsigned long long printed = 0; count == 0 || printed < count; printed++){
+		if(pos == size){
+			break;
+		}
+		if(pos + 24 > size){
+			error = inputName + ": record at byte " + to_string(pos) + " is cut off";
+			ok = false;
+			break;
+		}
+
+		packedProblem record;
+		record.initial = readLittleEndian(data + pos, 8);
+		record.goal = readLittleEndian(data + pos + 8, 8);
+		int depthVal = static_cast<int>(readLittleEndian(data + pos + 16, 4));
+		unsigned int nodeNum = static_cast<unsigned int>(readLittleEndian(data + pos + 20, 4));
+		size_t length = recordLength(data + pos);
+		if(pos + length > size){
+			error = inputName + ": record at byte " + to_string(pos) + " is cut off";
+			ok = false;
+			break;
+		}
+
+		//Replays the moves from the initial state to rebuild the move set and the f(n) values
+		sol solution;
+		solution.depth = depthVal;
+		solution.nodeNum = static_cast<int>(nodeNum);
+		solution.moveSet = "";
+		solution.funcSet = "";
+		if(depthVal >= 0){
+			solution.funcSet = to_string(calcHeuristicPacked(record.initial, record.goal)) + ' ';
+		}
+		unsigned long long cur = record.initial;
+		const char moveLetters[4] = {'U', 'D', 'L', 'R'};
+		for(int g = 0; g < depthVal; g++){
+			int code = (static_cast<unsigned char>(data[pos + 24 + g / 4]) >> (2 * (g % 4))) & 0x3;
+			solution.moveSet += moveLetters[code];
+			solution.moveSet += ' ';
+			movePacked(cur, code, cur);
+			solution.funcSet += to_string(g + 1 + calcHeuristicPacked(cur, record.goal)) + ' ';
+		}
+		pos += length;
+
+		if(!resultWriterAppend(output, record, solution)){
+			error = "cannot write to the standard output";
+			ok = false;
+			break;
+		}
+	}
+
+	munmap(mapped, size);
+	ok = resultWriterClose(output) && ok;
+	return ok;
+}
+
+//Function which prints the ways the program can be run
+void printUsage(string programName){
+	cerr << "Usage: " << programName << " <input file>" << endl;
+	cerr << "       " << programName << " --shared-goal [--max-nodes <n>] [--output <file> [--binary]] <input file> ..." << endl;
+	cerr << "       " << programName << " --read-results <file> [<first record> [<count>]]" << endl;
+}
+
+//Function which reads a whole number given as an argument to the program
+//Returns false if the argument is not made up only of digits, or is too large
+bool parseNumber(string argument, unsigned long long& value){
+	if(argument.empty() || argument.size() > 19){
+		return false;
+	}
+	value = 0;
+	for(size_t i = 0; i < argument.size(); i++){
+		if(!isdigit(static_cast<unsigned char>(argument[i]))){
+			return false;
+		}
+		value = value * 10 + (argument[i] - '0');
+	}
+	return true;
+}
+
 int main(int argc, char* argv[]){
+	if(argc < 2){
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	//Reader mode: prints the records of a binary result file in the text layout
+	if(string(argv[1]) == "--read-results"){
+		unsigned long long first = 0;
+		unsigned long long count = 0;
+		if(argc < 3 || argc > 5 || (argc > 3 && !parseNumber(argv[3], first)) || (argc > 4 && !parseNumber(argv[4], count))){
+			printUsage(argv[0]);
+			return 1;
+		}
+		string error;
+		if(!readResults(argv[2], first, count, error)){
+			cerr << error << endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	//Shared goal mode: every puzzle in every input file is solved with one reverse search tree grown
+	//from the goal, so problems which share a goal reuse the states generated for the earlier ones
+	//With --output, all of the results are appended to that one file instead of one file per puzzle
+	if(string(argv[1]) == "--shared-goal"){
+		reverseSearchTree tree;
+		string sinkName = "";
+		bool binary = false;
+		int argIndex = 2;
+		while(argIndex < argc){
+			string option = argv[argIndex];
+			if(option == "--max-nodes"){
+				unsigned long long maxNodes;
+				if(argIndex + 1 >= argc || !parseNumber(argv[argIndex + 1], maxNodes)){
+					printUsage(argv[0]);
+					return 1;
+				}
+				tree.maxNodes = static_cast<size_t>(maxNodes);
+				argIndex += 2;
+			}
+			else if(option == "--output"){
+				if(argIndex + 1 >= argc){
+					printUsage(argv[0]);
+					return 1;
+				}
+				sinkName = argv[argIndex + 1];
+				argIndex += 2;
+			}
+			else if(option == "--binary"){
+				binary = true;
+				argIndex++;
+			}
+			else{
+				break;
+			}
+		}
+		if(argIndex >= argc){
+			printUsage(argv[0]);
+			return 1;
+		}
+		if(binary && (sinkName == "" || sinkName == "-")){
+			cerr << "--binary needs --output <file>" << endl;
+			return 1;
+		}
+
+		string error;
+		resultWriter sink;
+		if(sinkName != "" && !resultWriterOpen(sink, sinkName, binary, false, error)){
+			cerr << error << endl;
+			return 1;
+		}
+
+		//Output files already written in this run. Two inputs can still lead to the same output file (such as
+		//"a.txt" and "dir/a.txt"), and the second is turned away rather than overwriting the results of the first
+		unordered_set<string> usedNames;
+
+		for(; argIndex < argc; argIndex++){
+			string inputName = argv[argIndex];
+			string outputName = outputFileName(inputName);
+
+			//Without --output, each puzzle gets its own output file. Files holding more than one puzzle get one
+			//output file per puzzle, numbered from 1. That is only known once a second puzzle has been read, so
+			//the result of the first puzzle is held back until then
+			size_t puzzleNum = 0;
+			packedProblem heldProblem;
+			sol heldSolution;
+			auto writeOwnFile = [&](string name, packedProblem problemPara, sol solution){
+				if(!usedNames.insert(name).second){
+					error = inputName + ": output file " + name + " was already written by an earlier input, rename the input file";
+					return false;
+				}
+				resultWriter output;
+				bool written = resultWriterOpen(output, name, false, true, error);
+				written = written && resultWriterAppend(output, problemPara, solution);
+				written = resultWriterClose(output) && written;
+				if(!written && error == ""){
+					error = name + ": cannot write results";
+				}
+				return written;
+			};
+			auto numberedName = [&](size_t k){
+				return outputName.substr(0, outputName.size() - 4) + "_" + to_string(k) + ".txt";
+			};
+
+			//Each puzzle is solved and written as soon as it is read
+			bool ok = parsePuzzleFile(inputName, [&](packedProblem next){
+				puzzleNum++;
+
+				//Puzzles which cannot be solved are reported without searching, and puzzles the tree cannot
+				//reach within its memory cap are reported as not solved
+				sol solution;
+				if(!isSolvable(next.initial, next.goal)){
+					solution.depth = depthUnsolvable;
+					solution.nodeNum = 0;
+				}
+				else if(!reverseTreeSolve(tree, next, solution)){
+					cerr << inputName << ": puzzle " << puzzleNum << " not solved within cap of " << tree.maxNodes << " nodes" << endl;
+				}
+
+				if(sinkName != ""){
+					if(!resultWriterAppend(sink, next, solution)){
+						error = sinkName + ": cannot write results";
+						return false;
+					}
+					return true;
+				}
+				if(puzzleNum == 1){
+					heldProblem = next;
+					heldSolution = solution;
+					return true;
+				}
+				if(puzzleNum == 2 && !writeOwnFile(numberedName(1), heldProblem, heldSolution)){
+					return false;
+				}
+				return writeOwnFile(numberedName(puzzleNum), next, solution);
+			}, error);
+			if(ok && sinkName == "" && puzzleNum == 1){
+				ok = writeOwnFile(outputName, heldProblem, heldSolution);
+			}
+
+			//The results already collected in the sink are still written out before stopping
+			if(!ok){
+				cerr << error << endl;
+				if(sinkName != ""){
+					resultWriterClose(sink);
+				}
+				return 1;
+			}
+		}
+
+		if(sinkName != "" && !resultWriterClose(sink)){
+			cerr << sinkName << ": cannot write results" << endl;
+			return 1;
+		}
+		return 0;
+	}
 
 	//Reads the argument given to the program and sets the corresponding input file to it
 	string inputName = argv[1];
 
 	//Reads from the input file and stores the initial state and goal state of the problem
-	problem = inputProcessing(inputName);
+	//Only one problem is solved in this mode, so files holding more than one are turned away
+	packedProblem problem;
+	size_t puzzleCount = 0;
+	string error;
+	bool parsed = parsePuzzleFile(inputName, [&](packedProblem next){
+		puzzleCount++;
+		if(puzzleCount > 1){
+			error = inputName + ": holds more than one puzzle, use --shared-goal to solve all of them";
+			return false;
+		}
+		problem = next;
+		return true;
+	}, error);
+	if(!parsed){
+		cerr << error << endl;
+		return 1;
+	}
 
 	//Uses the initial and goal states to solve the problem using a* search
-	sol solution = aStar(problem);
+	//Puzzles which cannot be solved are reported without searching, since a* search would never finish
+	sol solution;
+	if(!isSolvable(problem.initial, problem.goal)){
+		solution.depth = depthUnsolvable;
+		solution.nodeNum = 0;
+	}
+	else{
+		solution = aStar(problem);
+	}
 
 	//Creates an output file and writes to it
-	//If an input file is given and is in the format "Input<Number>", use the number
-	//to name the output file. Otherwise name the output file "aStarResults.txt"
-	string outputName = "";
-	size_t fIndex = inputName.find("Input");
-	if(fIndex == string::npos){
-		outputName = "aStarResults.txt";
-	}
-	else if((static_cast<int>(fIndex) + 5) != (inputName.size() - 1)){
-		int fIndexInt = static_cast<int>(fIndex);
-		char addOn = inputName[fIndexInt + 5];
-		outputName = "Output";
-		outputName.push_back(addOn);
-		outputName += ".txt";
-	}
-
-
-	ofstream output;
-	output.open(outputName);
-
-	//Outputs the original initial and goal states to the output file
-	stringstream initialPrint(problem.initial);
-	int count = 0;
-	while(initialPrint.good()){
-		string sub;
-		getline(initialPrint, sub, ',');
-		output << sub + ' ';
-		count++;
-		if(count >= 4){
-			count = 0;
-			output << endl;
-		}
-	}
-	output << endl;
-	stringstream goalPrint(problem.goal);
-	int goalCount = 0;
-	while(goalPrint.good()){
-		string sub;
-		getline(goalPrint, sub, ',');
-		output << sub + ' ';
-		goalCount++;
-		if(goalCount >= 4){
-			goalCount = 0;
-			output << endl;
-		}
-	}
-	output << endl;
-
-	//Ouputs the following information to the output file
-	//Depth of the shallowest goal node
-	//The total number of nodes generated
-	//The set of moves taken to get from the initial state to the goal state
-	//The f(n) value of each node from the root node to the goal node
-	output << solution.depth << endl;
-	output << solution.nodeNum << endl;
-	output << solution.moveSet << endl;
-	output << solution.funcSet << endl;
-
-	//Completes writing to the output file
-	output.close();
+	resultWriter output;
+	bool ok = resultWriterOpen(output, outputFileName(inputName), false, true, error);
+	ok = ok && resultWriterAppend(output, problem, solution);
+	ok = resultWriterClose(output) && ok;
+	if(!ok){
+		cerr << (error != "" ? error : "cannot write results") << endl;
+		return 1;
+	}
 	return 0;
 }